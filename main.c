@@ -9,6 +9,10 @@
 #include <stdlib.h>
 #include <time.h>
 
+#include "nav.h"
+#include "snapshot.h"
+#include "telemetry.h"
+
 // --- Game Constants ---
 const int SCREEN_W = 1280;
 const int SCREEN_H = 720;
@@ -38,10 +42,15 @@ const int MAX_MONSTER_PROJECTILES = 20;
 const float MONSTER_PROJECTILE_SPEED = 10.0;
 const float MONSTER_AGGRO_RANGE = 650.0;
 const float MONSTER_SHOOT_COOLDOWN = 1.0;
+const float MONSTER_SPEED = 3.0;
 const float MONSTER_CHECK_RADIUS = 300.0; // NEW: Radius for proximity check
 const int MAX_MONSTERS_IN_RADIUS =
     1; // NEW: Max monsters allowed in that radius
 
+// --- Rewind Constants ---
+const int SNAPSHOT_KEYFRAME_INTERVAL = 30;         // ticks between keyframes
+const size_t SNAPSHOT_HISTORY_BYTES = 1024 * 1024; // fixed rewind memory
+
 // --- World Generation Constants ---
 const float GROUND_Y = 630.0;
 const float PLATFORM_HEIGHT = 50.0;
@@ -83,6 +92,7 @@ typedef struct {
   int health;
   bool active;
   float shoot_cooldown;
+  NavBody body;
 } Monster;
 typedef struct {
   float x, y;
@@ -95,6 +105,7 @@ typedef struct {
   bool opened;
 } Door;
 typedef struct {
+  int id;
   char question[256];
   char answers[4][128];
   int correct_answer_idx;
@@ -114,6 +125,16 @@ MathQuestion current_question;
 int selected_answer = 0;
 int stage_count = 1;
 bool can_spawn_new_wave = true;
+Telemetry telemetry;
+uint32_t game_tick = 0;      // snapshotted, so it runs backwards on rewind
+uint32_t telemetry_tick = 0; // not snapshotted, stamps telemetry records
+uint32_t rewound_ticks = 0;  // ticks popped by the rewind in progress
+uint32_t stage_start_tick = 0;
+uint32_t wave_start_tick = 0;
+NavField nav;
+SnapshotLayout world_layout;
+SnapshotRing history;
+uint8_t *checkpoint = NULL; // world at the start of the current stage
 
 // Helper functions
 int random_int(int min, int max) { return min + rand() % (max - min + 1); }
@@ -123,14 +144,18 @@ void take_damage(Player *player) {
   player_lives--;
   player_invincibility_timer = PLAYER_INVINCIBILITY_DURATION;
   screen_flash_alpha = 150;
+  telemetry_emit(&telemetry, telemetry_tick, TELEMETRY_DAMAGE, stage_count,
+                 player_lives, 0, 0, player->x, player->y);
   if (player_lives <= 0) {
     game_state = GAME_OVER;
+    telemetry_emit(&telemetry, telemetry_tick, TELEMETRY_DEATH, stage_count,
+                   game_tick - stage_start_tick, 0, 0, player->x, player->y);
   }
 }
 void load_random_question(sqlite3 *db, MathQuestion *q) {
   sqlite3_stmt *res;
   const char *sql = "SELECT question, answer1, answer2, answer3, answer4, "
-                    "correctAnswer FROM maths ORDER BY RANDOM() LIMIT 1;";
+                    "correctAnswer, id FROM maths ORDER BY RANDOM() LIMIT 1;";
   if (sqlite3_prepare_v2(db, sql, -1, &res, 0) != SQLITE_OK) {
     fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db));
     return;
@@ -147,10 +172,27 @@ void load_random_question(sqlite3 *db, MathQuestion *q) {
     snprintf(q->answers[3], sizeof(q->answers[3]), "4. %s",
              sqlite3_column_text(res, 4));
     q->correct_answer_idx = sqlite3_column_int(res, 5) - 1;
+    q->id = sqlite3_column_int(res, 6);
   }
   sqlite3_finalize(res);
 }
 
+// The nav grid is derived from the platforms, so rebuild it after a restore
+void resync_nav(Platform platforms[], int num_platforms) {
+  nav_clear(&nav);
+  for (int i = 0; i < num_platforms; i++) {
+    nav_add_platform(&nav, platforms[i].x, platforms[i].y, platforms[i].width);
+  }
+}
+
+// Marks the current world as the stage start. Rewind history from before it
+// is dropped so holding R can't cross back into the previous stage.
+void save_checkpoint(void) {
+  if (checkpoint)
+    snapshot_capture(&world_layout, checkpoint);
+  snapshot_ring_clear(&history);
+}
+
 // NEW: Helper function to check monster density
 bool is_spawn_location_valid(float cx, float cy,
                              Monster monsters[MAX_MONSTERS]) {
@@ -188,6 +230,9 @@ int main(void) {
     fprintf(stderr, "Can't open database: %s\n", sqlite3_errmsg(db));
     return -1;
   }
+  // Telemetry is optional: if the log can't be mapped the game runs without it
+  telemetry_open(&telemetry, "telemetry", TELEMETRY_DEFAULT_SEGMENT_RECORDS,
+                 (uint32_t)FPS);
   al_register_event_source(event_queue, al_get_display_event_source(display));
   al_register_event_source(event_queue, al_get_timer_event_source(timer));
   al_register_event_source(event_queue, al_get_keyboard_event_source());
@@ -227,6 +272,45 @@ int main(void) {
   for (int i = 0; i < MAX_MONSTERS; i++) {
     monsters[i].active = false;
   }
+  nav_init(&nav, GROUND_Y, platform_lanes, GRAVITY, JUMP_STRENGTH,
+           MONSTER_SPEED);
+
+  // Everything a rewind or a checkpoint has to put back. The question
+  // screen and input are left out: snapshots are only taken while PLAYING.
+  snapshot_track(&world_layout, &player, sizeof(player));
+  snapshot_track(&world_layout, ground_segments, sizeof(ground_segments));
+  snapshot_track(&world_layout, platforms, sizeof(platforms));
+  snapshot_track(&world_layout, &num_platforms, sizeof(num_platforms));
+  snapshot_track(&world_layout, projectiles, sizeof(projectiles));
+  snapshot_track(&world_layout, monster_projectiles,
+                 sizeof(monster_projectiles));
+  snapshot_track(&world_layout, monsters, sizeof(monsters));
+  snapshot_track(&world_layout, &key, sizeof(key));
+  snapshot_track(&world_layout, &door, sizeof(door));
+  snapshot_track(&world_layout, &barrier, sizeof(barrier));
+  snapshot_track(&world_layout, lane_states, sizeof(lane_states));
+  snapshot_track(&world_layout, &camera_x, sizeof(camera_x));
+  snapshot_track(&world_layout, &wave_in_progress, sizeof(wave_in_progress));
+  snapshot_track(&world_layout, &monsters_to_spawn, sizeof(monsters_to_spawn));
+  snapshot_track(&world_layout, &active_monster_count,
+                 sizeof(active_monster_count));
+  snapshot_track(&world_layout, &last_monster_x, sizeof(last_monster_x));
+  snapshot_track(&world_layout, &game_state, sizeof(game_state));
+  snapshot_track(&world_layout, &player_lives, sizeof(player_lives));
+  snapshot_track(&world_layout, &player_invincibility_timer,
+                 sizeof(player_invincibility_timer));
+  snapshot_track(&world_layout, &screen_flash_alpha,
+                 sizeof(screen_flash_alpha));
+  snapshot_track(&world_layout, &stage_count, sizeof(stage_count));
+  snapshot_track(&world_layout, &can_spawn_new_wave,
+                 sizeof(can_spawn_new_wave));
+  snapshot_track(&world_layout, &game_tick, sizeof(game_tick));
+  snapshot_track(&world_layout, &stage_start_tick, sizeof(stage_start_tick));
+  snapshot_track(&world_layout, &wave_start_tick, sizeof(wave_start_tick));
+  snapshot_ring_init(&history, &world_layout, SNAPSHOT_HISTORY_BYTES,
+                     SNAPSHOT_KEYFRAME_INTERVAL);
+  checkpoint = malloc(world_layout.frame_size);
+  save_checkpoint();
 
   bool keys[ALLEGRO_KEY_MAX] = {false};
   bool running = true;
@@ -238,10 +322,29 @@ int main(void) {
     al_wait_for_event(event_queue, &event);
 
     if (event.type == ALLEGRO_EVENT_TIMER) {
+      // Session time: keeps running on the question and game over screens
+      telemetry_tick++;
       if (game_state != PLAYING) {
         redraw = true;
         continue;
       }
+      // Hold R to rewind one tick per tick for as long as history lasts
+      if (keys[ALLEGRO_KEY_R]) {
+        if (snapshot_ring_pop(&history)) {
+          resync_nav(platforms, num_platforms);
+          rewound_ticks++;
+        }
+        redraw = true;
+        continue;
+      }
+      if (rewound_ticks > 0) {
+        telemetry_emit(&telemetry, telemetry_tick, TELEMETRY_REWIND,
+                       stage_count, rewound_ticks, game_tick, 0, player.x,
+                       player.y);
+        rewound_ticks = 0;
+      }
+      snapshot_ring_push(&history);
+      game_tick++;
       if (player_invincibility_timer > 0)
         player_invincibility_timer -= 1.0 / FPS;
       if (screen_flash_alpha > 0)
@@ -298,11 +401,22 @@ int main(void) {
           ground_segments[i].x -= 3 * SCREEN_W;
         }
       }
+      // Nav window spans everything from the culling edge to the generator
+      if (nav_set_window(&nav, camera_x - CULLING_BUFFER - CHUNK_WIDTH)) {
+        for (int i = 0; i < num_platforms; i++) {
+          nav_refill_platform(&nav, platforms[i].x, platforms[i].y,
+                              platforms[i].width);
+        }
+      }
 
       if (can_spawn_new_wave && random_int(1, 100) <= MONSTER_SPAWN_CHANCE) {
         wave_in_progress = true;
         can_spawn_new_wave = false;
         monsters_to_spawn = random_int(6, 10);
+        wave_start_tick = game_tick;
+        telemetry_emit(&telemetry, telemetry_tick, TELEMETRY_WAVE_START,
+                       stage_count, monsters_to_spawn, 0, 0, player.x,
+                       player.y);
       }
 
       // REFACTORED: Platform & Monster Generation
@@ -323,6 +437,9 @@ int main(void) {
             platforms[num_platforms] =
                 (Platform){lane_states[i].last_x, platform_lanes[i],
                            CHUNK_WIDTH, PLATFORM_HEIGHT};
+            nav_add_platform(&nav, platforms[num_platforms].x,
+                             platforms[num_platforms].y,
+                             platforms[num_platforms].width);
             if (monsters_to_spawn > 0) {
               float candidate_x = platforms[num_platforms].x +
                                   platforms[num_platforms].width / 2;
@@ -336,6 +453,7 @@ int main(void) {
                         MONSTER_SHOOT_COOLDOWN + (random_int(0, 10) / 10.0);
                     monsters[m].x = candidate_x - MONSTER_SIZE / 2;
                     monsters[m].y = candidate_y;
+                    monsters[m].body = (NavBody){0, 0, false, 0};
                     active_monster_count++;
                     last_monster_x = monsters[m].x;
                     monsters_to_spawn--;
@@ -357,9 +475,13 @@ int main(void) {
         door.y = GROUND_Y - DOOR_HEIGHT;
         barrier.active = true;
         barrier.x = DOOR_WIDTH + door.x;
+        telemetry_emit(&telemetry, telemetry_tick, TELEMETRY_DOOR_SPAWNED,
+                       stage_count, 0, 0, 0, door.x, door.y);
       }
       for (int i = 0; i < num_platforms; i++) {
         if (platforms[i].x + platforms[i].width < camera_x - CULLING_BUFFER) {
+          nav_remove_platform(&nav, platforms[i].x, platforms[i].y,
+                              platforms[i].width);
           for (int j = i; j < num_platforms - 1; j++) {
             platforms[j] = platforms[j + 1];
           }
@@ -367,9 +489,12 @@ int main(void) {
           i--;
         }
       }
+      nav_update(&nav, player.x + PLAYER_SIZE / 2, player.y + PLAYER_SIZE);
 
       for (int i = 0; i < MAX_MONSTERS; i++) {
         if (monsters[i].active) {
+          nav_move_body(&nav, &monsters[i].body, &monsters[i].x,
+                        &monsters[i].y, MONSTER_SIZE, player.x);
           if (player.x + PLAYER_SIZE > monsters[i].x &&
               player.x < monsters[i].x + MONSTER_SIZE &&
               player.y + PLAYER_SIZE > monsters[i].y &&
@@ -419,6 +544,10 @@ int main(void) {
                     key.x = monsters[j].x + MONSTER_SIZE / 2;
                     key.y = monsters[j].y + MONSTER_SIZE / 2;
                     wave_in_progress = false;
+                    telemetry_emit(&telemetry, telemetry_tick,
+                                   TELEMETRY_WAVE_CLEARED, stage_count,
+                                   game_tick - wave_start_tick, 0, 0, key.x,
+                                   key.y);
                   }
                 }
                 break;
@@ -466,6 +595,9 @@ int main(void) {
             game_state = QUESTION;
             load_random_question(db, &current_question);
             selected_answer = 0;
+            telemetry_emit(&telemetry, telemetry_tick, TELEMETRY_QUESTION_SHOWN,
+                           stage_count, current_question.id, 0, 0, player.x,
+                           player.y);
           }
         }
       }
@@ -492,8 +624,17 @@ int main(void) {
           break;
         case ALLEGRO_KEY_ENTER:
         case ALLEGRO_KEY_SPACE:
+          telemetry_emit(
+              &telemetry, telemetry_tick, TELEMETRY_ANSWER, stage_count,
+              current_question.id, selected_answer,
+              selected_answer == current_question.correct_answer_idx,
+              player.x, player.y);
           if (selected_answer == current_question.correct_answer_idx) {
             barrier.active = false;
+            telemetry_emit(&telemetry, telemetry_tick, TELEMETRY_STAGE_CLEAR,
+                           stage_count, game_tick - stage_start_tick, 0, 0,
+                           player.x, player.y);
+            stage_start_tick = game_tick;
             if (stage_count >= STAGES_TO_WIN) {
               game_state = WON;
             } else {
@@ -502,13 +643,27 @@ int main(void) {
               key.collected = false;
               can_spawn_new_wave = true;
               game_state = PLAYING;
+              save_checkpoint();
             }
           } else {
             take_damage(&player);
-            game_state = PLAYING;
+            // A wrong answer on the last life ends the game
+            if (game_state == QUESTION)
+              game_state = PLAYING;
           }
           break;
         }
+      } else if (game_state == GAME_OVER && checkpoint &&
+                 event.keyboard.keycode == ALLEGRO_KEY_ENTER) {
+        // Retry the stage from its checkpoint with full lives
+        uint32_t died_at = game_tick;
+        snapshot_restore(&world_layout, checkpoint);
+        telemetry_emit(&telemetry, telemetry_tick, TELEMETRY_RETRY,
+                       stage_count, died_at - game_tick, 0, 0, player.x,
+                       player.y);
+        snapshot_ring_clear(&history);
+        resync_nav(platforms, num_platforms);
+        player_lives = PLAYER_STARTING_LIVES;
       }
     } else if (event.type == ALLEGRO_EVENT_KEY_UP) {
       keys[event.keyboard.keycode] = false;
@@ -632,10 +787,16 @@ int main(void) {
       if (game_state == GAME_OVER) {
         al_draw_text(font, al_map_rgb(255, 50, 50), SCREEN_W / 2,
                      SCREEN_H / 2 - 20, ALLEGRO_ALIGN_CENTER, "GAME OVER");
+        al_draw_text(ui_font, al_map_rgb(255, 255, 255), SCREEN_W / 2,
+                     SCREEN_H / 2 + 30, ALLEGRO_ALIGN_CENTER,
+                     "Press ENTER to retry the stage");
       }
       al_flip_display();
     }
   }
+  snapshot_ring_free(&history);
+  free(checkpoint);
+  telemetry_close(&telemetry);
   sqlite3_close(db);
   al_destroy_font(font);
   al_destroy_font(ui_font);
@@ -0,0 +1,339 @@
+#include "nav.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define NAV_NONE 0xFFFF
+// Edge costs are in columns walked; jumps and drops pay a little extra so
+// bodies walk along flat ground instead of hopping.
+#define NAV_WALK_COST 1
+#define NAV_DROP_COST 4
+#define NAV_JUMP_COST 8
+
+static int slot_of(long col) {
+  return (int)((unsigned long)col & (NAV_COLUMNS - 1));
+}
+static int node_of(long col, int level) {
+  return slot_of(col) * NAV_LEVELS + level;
+}
+static long column_of(float x) { return (long)floorf(x / NAV_CELL_WIDTH); }
+static bool in_window(const NavField *nav, long col) {
+  return col >= nav->left_col && col < nav->left_col + NAV_COLUMNS;
+}
+// The ground segments tile the whole view, so the ground is always standable.
+static bool standable(const NavField *nav, long col, int level) {
+  if (level == 0)
+    return true;
+  return in_window(nav, col) && nav->standable[slot_of(col)][level];
+}
+static int level_of(const NavField *nav, float y) {
+  for (int l = 1; l < NAV_LEVELS; l++) {
+    if (fabsf(nav->level_y[l] - y) < 0.5f)
+      return l;
+  }
+  return -1;
+}
+
+// Where a body falls to when it leaves `level` in column `col`.
+static int landing_below(const NavField *nav, long col, int level) {
+  for (int l = level - 1; l > 0; l--) {
+    if (standable(nav, col, l))
+      return l;
+  }
+  return 0;
+}
+// Where a jump from (`col`, `level`) moving `side` columns per step comes
+// down. Platforms can be passed from below, so on the way down the body is
+// caught by the first surface it crosses, highest first.
+static int jump_landing(const NavField *nav, long col, int level, int side,
+                        long *land_col) {
+  for (int l = NAV_LEVELS - 1; l >= 0; l--) {
+    int cols = nav->jump_cols[level][l];
+    if (cols < 0)
+      continue;
+    *land_col = col + side * cols;
+    if (standable(nav, *land_col, l))
+      return l;
+  }
+  *land_col = col;
+  return 0;
+}
+// Nearest standable surface at or below the feet.
+static int locate(const NavField *nav, long col, float feet_y) {
+  for (int l = NAV_LEVELS - 1; l >= 0; l--) {
+    if (nav->level_y[l] >= feet_y - 1 && standable(nav, col, l))
+      return l;
+  }
+  return 0;
+}
+
+void nav_init(NavField *nav, float ground_y, const float *lane_y,
+              float gravity, float jump_strength, float speed) {
+  memset(nav, 0, sizeof(*nav));
+  nav->level_y[0] = ground_y;
+  for (int l = 1; l < NAV_LEVELS; l++) {
+    nav->level_y[l] = lane_y[l - 1];
+  }
+  nav->gravity = gravity;
+  nav->jump_strength = jump_strength;
+  nav->speed = speed;
+  // Step the same integration the game uses and note, for every pair of
+  // levels, how far the arc has travelled when it comes down through the
+  // destination surface.
+  float apex = 0, vy = jump_strength;
+  for (float y = 0; vy + gravity < 0;) {
+    vy += gravity;
+    y += vy;
+    apex = y;
+  }
+  for (int from = 0; from < NAV_LEVELS; from++) {
+    for (int to = 0; to < NAV_LEVELS; to++) {
+      float drop = nav->level_y[to] - nav->level_y[from];
+      nav->jump_cols[from][to] = -1;
+      if (drop < apex)
+        continue;
+      vy = jump_strength;
+      float y = 0;
+      int ticks = 0;
+      while (vy <= 0 || y < drop) {
+        vy += gravity;
+        y += vy;
+        ticks++;
+      }
+      int cols = (int)lroundf(speed * ticks / NAV_CELL_WIDTH);
+      // The bucket queue only tells costs apart modulo NAV_BUCKETS, so an
+      // edge that costs that much would be settled too early. Leave such a
+      // jump out rather than route along it wrongly.
+      if (NAV_JUMP_COST + cols >= NAV_BUCKETS) {
+        fprintf(stderr, "Nav: jump from level %d to %d spans %d columns, "
+                        "raise NAV_BUCKETS.\n",
+                from, to, cols);
+        continue;
+      }
+      nav->jump_cols[from][to] = cols;
+    }
+  }
+  nav->target = -1;
+  nav->dirty = true;
+}
+
+bool nav_set_window(NavField *nav, float left_x) {
+  long left = column_of(left_x);
+  if (left == nav->left_col)
+    return false;
+  long old_lo = nav->left_col, old_hi = nav->left_col + NAV_COLUMNS;
+  long lo = left, hi = left + NAV_COLUMNS;
+  nav->left_col = left;
+  // Columns that entered reuse the slots of the ones that left.
+  nav->fill_lo = lo < old_lo ? lo : (old_hi > lo ? old_hi : lo);
+  nav->fill_hi = lo < old_lo ? (hi < old_lo ? hi : old_lo) : hi;
+  for (long c = nav->fill_lo; c < nav->fill_hi; c++) {
+    memset(nav->standable[slot_of(c)], 0, sizeof(nav->standable[0]));
+  }
+  nav->dirty = true;
+  return true;
+}
+
+static void mark_platform(NavField *nav, float x, float y, float width,
+                          long lo, long hi, bool value) {
+  int level = level_of(nav, y);
+  if (level < 0)
+    return;
+  long first = column_of(x), last = column_of(x + width - 1);
+  if (first < lo)
+    first = lo;
+  if (last >= hi)
+    last = hi - 1;
+  for (long c = first; c <= last; c++) {
+    nav->standable[slot_of(c)][level] = value;
+  }
+  if (first <= last)
+    nav->dirty = true;
+}
+
+void nav_add_platform(NavField *nav, float x, float y, float width) {
+  mark_platform(nav, x, y, width, nav->left_col, nav->left_col + NAV_COLUMNS,
+                true);
+}
+
+void nav_remove_platform(NavField *nav, float x, float y, float width) {
+  mark_platform(nav, x, y, width, nav->left_col, nav->left_col + NAV_COLUMNS,
+                false);
+}
+
+void nav_refill_platform(NavField *nav, float x, float y, float width) {
+  mark_platform(nav, x, y, width, nav->fill_lo, nav->fill_hi, true);
+}
+
+void nav_clear(NavField *nav) {
+  memset(nav->standable, 0, sizeof(nav->standable));
+  nav->dirty = true;
+}
+
+// Insert or move `n` to the bucket for cost `cost`.
+static void relax(NavField *nav, long col, int level, int cost,
+                  NavAction action) {
+  int n = node_of(col, level);
+  if (cost >= nav->dist[n])
+    return;
+  if (nav->queued[n]) {
+    if (nav->prev[n] != NAV_NONE)
+      nav->next[nav->prev[n]] = nav->next[n];
+    else
+      nav->bucket[nav->dist[n] % NAV_BUCKETS] = nav->next[n];
+    if (nav->next[n] != NAV_NONE)
+      nav->prev[nav->next[n]] = nav->prev[n];
+  } else {
+    nav->queued[n] = true;
+    nav->pending++;
+  }
+  int b = cost % NAV_BUCKETS;
+  nav->dist[n] = (uint16_t)cost;
+  nav->action[n] = (uint8_t)action;
+  nav->prev[n] = NAV_NONE;
+  nav->next[n] = nav->bucket[b];
+  if (nav->bucket[b] != NAV_NONE)
+    nav->prev[nav->bucket[b]] = (uint16_t)n;
+  nav->bucket[b] = (uint16_t)n;
+}
+
+// Dijkstra with a bucket queue (edge costs are small integers), run backwards
+// from the target: for each node settled, find every node with an edge into
+// it and point that node along the edge.
+static void build_field(NavField *nav, long target_col, int target_level) {
+  memset(nav->dist, 0xFF, sizeof(nav->dist));
+  memset(nav->action, NAV_IDLE, sizeof(nav->action));
+  memset(nav->queued, 0, sizeof(nav->queued));
+  memset(nav->bucket, 0xFF, sizeof(nav->bucket));
+  nav->pending = 0;
+  relax(nav, target_col, target_level, 0, NAV_ARRIVED);
+  for (int d = 0; nav->pending > 0; d++) {
+    int v;
+    while ((v = nav->bucket[d % NAV_BUCKETS]) != NAV_NONE) {
+      nav->bucket[d % NAV_BUCKETS] = nav->next[v];
+      if (nav->next[v] != NAV_NONE)
+        nav->prev[nav->next[v]] = NAV_NONE;
+      nav->queued[v] = false;
+      nav->pending--;
+      int level = v % NAV_LEVELS;
+      long col = nav->left_col + ((v / NAV_LEVELS - slot_of(nav->left_col)) &
+                                  (NAV_COLUMNS - 1));
+      for (int side = -1; side <= 1; side += 2) {
+        long from = col + side;
+        if (!in_window(nav, from))
+          continue;
+        NavAction toward = side < 0 ? NAV_RIGHT : NAV_LEFT;
+        for (int l = level; l < NAV_LEVELS; l++) {
+          if (!standable(nav, from, l))
+            continue;
+          // Walk along the level, or walk off its edge and fall onto ours.
+          if (l == level || (!standable(nav, col, l) &&
+                             landing_below(nav, col, l) == level))
+            relax(nav, from, l, d + NAV_WALK_COST, toward);
+        }
+      }
+      for (int l = level + 1; l < NAV_LEVELS; l++) {
+        if (standable(nav, col, l) && landing_below(nav, col, l) == level)
+          relax(nav, col, l, d + NAV_DROP_COST, NAV_DROP);
+      }
+      for (int side = -1; side <= 1; side++) {
+        NavAction jump = side < 0   ? NAV_JUMP_LEFT
+                         : side > 0 ? NAV_JUMP_RIGHT
+                                    : NAV_JUMP;
+        for (int l = 0; l < NAV_LEVELS; l++) {
+          int cols = nav->jump_cols[l][level];
+          long from = col - side * cols, land_col;
+          if (cols < 0 || (side == 0 && l == level) || !in_window(nav, from) ||
+              !standable(nav, from, l))
+            continue;
+          if (jump_landing(nav, from, l, side, &land_col) == level &&
+              land_col == col)
+            relax(nav, from, l, d + NAV_JUMP_COST + (side ? cols : 0), jump);
+        }
+      }
+    }
+  }
+}
+
+bool nav_update(NavField *nav, float target_x, float target_feet_y) {
+  long col = column_of(target_x);
+  if (!in_window(nav, col))
+    return false;
+  int level = locate(nav, col, target_feet_y);
+  int target = node_of(col, level);
+  if (!nav->dirty && target == nav->target)
+    return false;
+  build_field(nav, col, level);
+  nav->target = target;
+  nav->dirty = false;
+  return true;
+}
+
+NavAction nav_steer(const NavField *nav, float x, float feet_y) {
+  long col = column_of(x);
+  if (nav->target < 0 || !in_window(nav, col))
+    return NAV_IDLE;
+  return (NavAction)nav->action[node_of(col, locate(nav, col, feet_y))];
+}
+
+void nav_move_body(const NavField *nav, NavBody *body, float *x, float *y,
+                   float size, float chase_x) {
+  float feet = *y + size;
+  bool grounded = body->on_ground;
+  if (grounded) {
+    body->vx = 0;
+    switch (nav_steer(nav, *x + size / 2, feet)) {
+    case NAV_LEFT:
+      body->vx = -nav->speed;
+      break;
+    case NAV_RIGHT:
+      body->vx = nav->speed;
+      break;
+    case NAV_JUMP_LEFT:
+      body->vx = -nav->speed;
+      body->vy = nav->jump_strength;
+      break;
+    case NAV_JUMP_RIGHT:
+      body->vx = nav->speed;
+      body->vy = nav->jump_strength;
+      break;
+    case NAV_JUMP:
+      body->vy = nav->jump_strength;
+      break;
+    case NAV_DROP:
+      body->drop_from = feet;
+      break;
+    case NAV_ARRIVED:
+      body->vx = fmaxf(-nav->speed, fminf(nav->speed, chase_x - *x));
+      break;
+    case NAV_IDLE:
+      break;
+    }
+  }
+  body->vy += nav->gravity;
+  float next_feet = feet + body->vy;
+  *x += body->vx;
+  body->on_ground = false;
+  if (body->vy >= 0) {
+    // Same one-way landing rule as the player: only catch surfaces the feet
+    // were above at the start of the tick.
+    long col = column_of(*x + size / 2);
+    for (int l = NAV_LEVELS - 1; l >= 0; l--) {
+      float s = nav->level_y[l];
+      if (s <= body->drop_from || !standable(nav, col, l))
+        continue;
+      if (feet <= s + (nav->gravity + 1) && next_feet >= s) {
+        next_feet = s;
+        body->vy = 0;
+        body->on_ground = true;
+        body->drop_from = 0;
+        break;
+      }
+    }
+  }
+  // Walking off an edge falls straight down, as the walk-off edges assume.
+  if (grounded && !body->on_ground && body->vy > 0)
+    body->vx = 0;
+  *y = next_feet - size;
+}
@@ -0,0 +1,82 @@
+#ifndef NAV_H
+#define NAV_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// --- Navigation Constants ---
+// Every platform x is a multiple of 10 (lanes start at 400/500/600 and step by
+// CHUNK_WIDTH), so 10px columns line up exactly with platform edges.
+#define NAV_CELL_WIDTH 10.0f
+#define NAV_COLUMNS 512 // ring of columns, must be a power of two
+#define NAV_LEVELS 4    // ground + the three platform lanes
+#define NAV_NODES (NAV_COLUMNS * NAV_LEVELS)
+#define NAV_BUCKETS 64 // must exceed the costliest edge, checked in nav_init()
+
+typedef enum {
+  NAV_IDLE = 0, // outside the window or no route to the target
+  NAV_LEFT,
+  NAV_RIGHT,
+  NAV_JUMP, // straight up
+  NAV_JUMP_LEFT,
+  NAV_JUMP_RIGHT,
+  NAV_DROP,
+  NAV_ARRIVED, // same node as the target, close in directly
+} NavAction;
+
+// Movement state for anything steered by the field.
+typedef struct {
+  float vx, vy;
+  bool on_ground;
+  float drop_from; // surface being dropped through, 0 when not dropping
+} NavBody;
+
+// Nav graph over a sliding window of columns. Nodes are (column, level) cells
+// a body can stand on; edges are walk, walk-off, drop and standing or running
+// jumps. The flow field stores, per node, the first move on a shortest route
+// to the target.
+typedef struct {
+  float level_y[NAV_LEVELS]; // surface y, level 0 is the ground
+  float gravity;
+  float jump_strength;
+  float speed;
+  // Columns travelled by a running jump from one level until it comes down
+  // through another, -1 if that level is out of reach.
+  int jump_cols[NAV_LEVELS][NAV_LEVELS];
+  long left_col; // absolute column held by the first window slot
+  long fill_lo, fill_hi; // columns that entered on the last nav_set_window()
+  int target; // node the field points at, -1 before the first update
+  bool dirty;
+  bool standable[NAV_COLUMNS][NAV_LEVELS]; // ring-indexed by column
+  uint8_t action[NAV_NODES];
+  uint16_t dist[NAV_NODES];
+  // Bucket queue used while building the field.
+  bool queued[NAV_NODES];
+  uint16_t next[NAV_NODES], prev[NAV_NODES];
+  uint16_t bucket[NAV_BUCKETS];
+  int pending;
+} NavField;
+
+// `lane_y` lists the platform lanes from lowest to highest. The field is built
+// for bodies that move at `speed` and jump like the player.
+void nav_init(NavField *nav, float ground_y, const float *lane_y,
+              float gravity, float jump_strength, float speed);
+// Slides the window so it starts at `left_x`. Returns true if new columns
+// entered; resident platforms must then be passed to nav_refill_platform().
+bool nav_set_window(NavField *nav, float left_x);
+void nav_add_platform(NavField *nav, float x, float y, float width);
+void nav_remove_platform(NavField *nav, float x, float y, float width);
+void nav_refill_platform(NavField *nav, float x, float y, float width);
+// Forgets every platform, for when the world is replaced wholesale.
+void nav_clear(NavField *nav);
+// Rebuilds the flow field if the graph changed or the target moved to another
+// node. Returns true if it was rebuilt.
+bool nav_update(NavField *nav, float target_x, float target_feet_y);
+NavAction nav_steer(const NavField *nav, float x, float feet_y);
+// One physics tick for a body of `size` following the field; `chase_x` is the
+// target's x, used once the body shares its node. Bodies only steer while on
+// the ground, so jumps follow the arc the field was built for.
+void nav_move_body(const NavField *nav, NavBody *body, float *x, float *y,
+                   float size, float chase_x);
+
+#endif
@@ -0,0 +1,135 @@
+#include "nav.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Runs the main.c world generator with thousands of monsters chasing a player
+// that paces back and forth, and times the flow field rebuilds and the
+// per-monster step. The constants mirror main.c.
+#define MAX_PLATFORMS 256
+static const float GROUND_Y = 630.0;
+static const float GRAVITY = 0.3;
+static const float JUMP_STRENGTH = -13.0;
+static const float PLAYER_SPEED = 8.0;
+static const float MONSTER_SIZE = 32.0;
+static const float MONSTER_SPEED = 3.0;
+static const int CHUNK_WIDTH = 190;
+static const int CULLING_BUFFER = 3000;
+static const int SCREEN_W = 1280;
+static const float platform_lanes[] = {500.0, 360.0, 240.0};
+
+typedef struct {
+    float x, y, width;
+} Platform;
+typedef struct {
+    float x, y;
+    NavBody body;
+} Monster;
+
+static double now_ns(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+    int monster_count = argc > 1 ? atoi(argv[1]) : 5000;
+    int ticks = argc > 2 ? atoi(argv[2]) : 2000;
+    srand(1234);
+
+    static NavField nav;
+    static Platform platforms[MAX_PLATFORMS];
+    int num_platforms = 0;
+    float lane_x[3] = {400, 500, 600};
+    int lane_left[3] = {0, 0, 0};
+    bool lane_gap[3] = {false, false, false};
+    Monster *monsters = calloc(monster_count, sizeof(Monster));
+    if (!monsters) {
+        return 1;
+    }
+
+    nav_init(&nav, GROUND_Y, platform_lanes, GRAVITY, JUMP_STRENGTH,
+             MONSTER_SPEED);
+    float player_x = 100;
+    float player_feet = GROUND_Y;
+    for (int i = 0; i < monster_count; i++) {
+        monsters[i].x = player_x - 1200 + rand() % 2800;
+        monsters[i].y = GROUND_Y - MONSTER_SIZE;
+    }
+
+    double field_ns = 0, move_ns = 0;
+    int rebuilds = 0;
+    for (int t = 0; t < ticks; t++) {
+        player_x += (t / 400) % 2 ? -PLAYER_SPEED : PLAYER_SPEED;
+        float camera_x = player_x - SCREEN_W / 3.0;
+
+        double start = now_ns();
+        if (nav_set_window(&nav, camera_x - CULLING_BUFFER - CHUNK_WIDTH)) {
+            for (int i = 0; i < num_platforms; i++) {
+                nav_refill_platform(&nav, platforms[i].x, platforms[i].y,
+                                    platforms[i].width);
+            }
+        }
+        for (int l = 0; l < 3; l++) {
+            while (lane_x[l] < camera_x + SCREEN_W + CHUNK_WIDTH) {
+                if (lane_left[l] <= 0) {
+                    lane_gap[l] = rand() % 100 >= 60;
+                    lane_left[l] =
+                        lane_gap[l] ? 2 + rand() % 3 : 3 + rand() % 6;
+                }
+                if (!lane_gap[l] && num_platforms < MAX_PLATFORMS) {
+                    platforms[num_platforms] =
+                        (Platform){lane_x[l], platform_lanes[l], CHUNK_WIDTH};
+                    nav_add_platform(&nav, lane_x[l], platform_lanes[l],
+                                     CHUNK_WIDTH);
+                    num_platforms++;
+                }
+                lane_x[l] += CHUNK_WIDTH;
+                lane_left[l]--;
+            }
+        }
+        for (int i = 0; i < num_platforms; i++) {
+            float right = platforms[i].x + platforms[i].width;
+            if (right < camera_x - CULLING_BUFFER) {
+                nav_remove_platform(&nav, platforms[i].x, platforms[i].y,
+                                    platforms[i].width);
+                platforms[i--] = platforms[--num_platforms];
+            }
+        }
+        rebuilds += nav_update(&nav, player_x, player_feet);
+        double mid = now_ns();
+
+        for (int i = 0; i < monster_count; i++) {
+            nav_move_body(&nav, &monsters[i].body, &monsters[i].x,
+                          &monsters[i].y, MONSTER_SIZE, player_x);
+        }
+        double end = now_ns();
+        field_ns += mid - start;
+        move_ns += end - mid;
+    }
+
+    int routed = 0;
+    for (int i = 0; i < monster_count; i++) {
+        routed += nav_steer(&nav, monsters[i].x + MONSTER_SIZE / 2,
+                            monsters[i].y + MONSTER_SIZE) != NAV_IDLE;
+    }
+    double rebuild_us = rebuilds ? field_ns / rebuilds / 1000 : 0;
+
+    printf("%d monsters, %d ticks, %d field rebuilds\n", monster_count, ticks,
+           rebuilds);
+    printf("field:   %.2f us/tick (%.2f us per rebuild)\n",
+           field_ns / ticks / 1000, rebuild_us);
+    // Not incremental: any window slide or platform change redoes the
+    // whole field, so a moving player pays this every tick.
+    printf("rebuild: full window on %d/%d ticks, no incremental update\n",
+           rebuilds, ticks);
+    printf("monster: %.2f ns/monster/tick, %.3f ms/tick total\n",
+           move_ns / ticks / monster_count, move_ns / ticks / 1e6);
+    printf("%d/%d monsters have a route to the player\n", routed,
+           monster_count);
+
+    free(monsters);
+
+    return 0;
+}
@@ -0,0 +1,219 @@
+#include "snapshot.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Deltas are runs of [u16 skip][u16 length][length XOR bytes]; equal stretches
+// shorter than this stay inside a run since a new header costs as much.
+#define SNAPSHOT_MIN_SKIP 4
+#define SNAPSHOT_RUN_HEADER 4
+
+void snapshot_track(SnapshotLayout *layout, void *ptr, size_t size) {
+  if (layout->count >= SNAPSHOT_MAX_REGIONS ||
+      layout->frame_size + size > UINT16_MAX) {
+    fprintf(stderr, "Snapshot layout is full, region not tracked.\n");
+    return;
+  }
+  layout->ptr[layout->count] = ptr;
+  layout->size[layout->count] = size;
+  layout->count++;
+  layout->frame_size += size;
+}
+
+void snapshot_capture(const SnapshotLayout *layout, uint8_t *frame) {
+  for (int i = 0; i < layout->count; i++) {
+    memcpy(frame, layout->ptr[i], layout->size[i]);
+    frame += layout->size[i];
+  }
+}
+
+void snapshot_restore(const SnapshotLayout *layout, const uint8_t *frame) {
+  for (int i = 0; i < layout->count; i++) {
+    memcpy(layout->ptr[i], frame, layout->size[i]);
+    frame += layout->size[i];
+  }
+}
+
+// XOR `frame` against `key` into `out`. Returns the encoded size, or -1 if it
+// would not be smaller than `cap`.
+static long encode_delta(const uint8_t *key, const uint8_t *frame, size_t n,
+                         uint8_t *out, size_t cap) {
+  size_t i = 0, pos = 0;
+  while (i < n) {
+    size_t skip_start = i;
+    while (i < n && key[i] == frame[i])
+      i++;
+    if (i == n)
+      break;
+    size_t start = i;
+    while (i < n) {
+      size_t same = 0;
+      while (i + same < n && key[i + same] == frame[i + same])
+        same++;
+      if (same >= SNAPSHOT_MIN_SKIP || i + same == n)
+        break;
+      i += same + 1;
+    }
+    uint16_t skip = (uint16_t)(start - skip_start);
+    uint16_t len = (uint16_t)(i - start);
+    if (pos + SNAPSHOT_RUN_HEADER + len >= cap)
+      return -1;
+    memcpy(out + pos, &skip, 2);
+    memcpy(out + pos + 2, &len, 2);
+    pos += SNAPSHOT_RUN_HEADER;
+    for (size_t k = 0; k < len; k++) {
+      out[pos + k] = key[start + k] ^ frame[start + k];
+    }
+    pos += len;
+  }
+  return (long)pos;
+}
+
+static void decode_delta(const uint8_t *key, const uint8_t *delta,
+                         size_t size, uint8_t *out, size_t n) {
+  memcpy(out, key, n);
+  size_t pos = 0, at = 0;
+  while (pos < size) {
+    uint16_t skip, len;
+    memcpy(&skip, delta + pos, 2);
+    memcpy(&len, delta + pos + 2, 2);
+    pos += SNAPSHOT_RUN_HEADER;
+    at += skip;
+    for (size_t k = 0; k < len; k++) {
+      out[at + k] ^= delta[pos + k];
+    }
+    at += len;
+    pos += len;
+  }
+}
+
+static SnapshotEntry *entry(SnapshotRing *ring, uint32_t seq) {
+  return &ring->entries[seq % SNAPSHOT_MAX_ENTRIES];
+}
+
+// Drops the oldest frame; dropping a keyframe also drops the deltas that
+// were encoded against it.
+static void evict_oldest(SnapshotRing *ring) {
+  bool keyframe = entry(ring, ring->first)->keyframe;
+  ring->first++;
+  ring->count--;
+  while (keyframe && ring->count > 0 && !entry(ring, ring->first)->keyframe) {
+    ring->first++;
+    ring->count--;
+  }
+}
+
+// Makes `size` contiguous bytes free at the head, wrapping to the start of
+// the arena if the tail is too short. Frames past the head are always the
+// oldest ones, so eviction stays FIFO.
+static void reserve(SnapshotRing *ring, size_t size) {
+  if (ring->count == SNAPSHOT_MAX_ENTRIES)
+    evict_oldest(ring);
+  if (ring->head + size > ring->arena_size) {
+    while (ring->count > 0 && entry(ring, ring->first)->offset >= ring->head)
+      evict_oldest(ring);
+    ring->head = 0;
+  }
+  // The oldest frame is always a keyframe, so it is never empty and sits
+  // below the head only if the arena has not wrapped under it yet.
+  while (ring->count > 0) {
+    SnapshotEntry *e = entry(ring, ring->first);
+    if (e->offset < ring->head || e->offset >= ring->head + size)
+      break;
+    evict_oldest(ring);
+  }
+}
+
+bool snapshot_ring_init(SnapshotRing *ring, const SnapshotLayout *layout,
+                        size_t arena_size, int keyframe_interval) {
+  memset(ring, 0, sizeof(*ring));
+  if (arena_size < 2 * layout->frame_size) {
+    fprintf(stderr, "Snapshot arena too small for two frames.\n");
+    return false;
+  }
+  ring->layout = layout;
+  ring->arena_size = arena_size;
+  ring->keyframe_interval = keyframe_interval > 0 ? keyframe_interval : 1;
+  ring->arena = malloc(arena_size);
+  ring->frame = malloc(layout->frame_size);
+  ring->encoded = malloc(layout->frame_size);
+  if (!ring->arena || !ring->frame || !ring->encoded) {
+    fprintf(stderr, "Could not allocate snapshot history.\n");
+    snapshot_ring_free(ring);
+    return false;
+  }
+  return true;
+}
+
+void snapshot_ring_free(SnapshotRing *ring) {
+  free(ring->arena);
+  free(ring->frame);
+  free(ring->encoded);
+  ring->arena = ring->frame = ring->encoded = NULL;
+  ring->count = 0;
+}
+
+void snapshot_ring_clear(SnapshotRing *ring) {
+  ring->first += ring->count;
+  ring->count = 0;
+  ring->head = 0;
+}
+
+void snapshot_ring_push(SnapshotRing *ring) {
+  if (!ring->arena)
+    return;
+  size_t n = ring->layout->frame_size;
+  uint32_t seq = ring->first + ring->count;
+  snapshot_capture(ring->layout, ring->frame);
+
+  long delta = -1;
+  bool have_key = ring->count > 0 && ring->key >= ring->first &&
+                  ring->key < seq &&
+                  seq - ring->key < (uint32_t)ring->keyframe_interval;
+  if (have_key) {
+    delta = encode_delta(ring->arena + entry(ring, ring->key)->offset,
+                         ring->frame, n, ring->encoded, n);
+  }
+  if (delta >= 0) {
+    reserve(ring, (size_t)delta);
+    // Making room may have evicted the keyframe the delta points at.
+    if (ring->key < ring->first)
+      delta = -1;
+  }
+  const uint8_t *data = ring->frame;
+  size_t size = n;
+  if (delta >= 0) {
+    data = ring->encoded;
+    size = (size_t)delta;
+  } else {
+    reserve(ring, n);
+  }
+  seq = ring->first + ring->count;
+  memcpy(ring->arena + ring->head, data, size);
+  *entry(ring, seq) = (SnapshotEntry){(uint32_t)ring->head, (uint32_t)size,
+                                      delta >= 0 ? ring->key : seq, delta < 0};
+  if (delta < 0)
+    ring->key = seq;
+  ring->count++;
+  ring->head += size;
+  ring->bytes_pushed += size;
+  ring->frames_pushed++;
+}
+
+bool snapshot_ring_pop(SnapshotRing *ring) {
+  if (!ring->arena || ring->count == 0)
+    return false;
+  SnapshotEntry *e = entry(ring, ring->first + ring->count - 1);
+  if (e->keyframe) {
+    snapshot_restore(ring->layout, ring->arena + e->offset);
+  } else {
+    decode_delta(ring->arena + entry(ring, e->key)->offset,
+                 ring->arena + e->offset, e->size, ring->frame,
+                 ring->layout->frame_size);
+    snapshot_restore(ring->layout, ring->frame);
+  }
+  ring->count--;
+  ring->head = e->offset;
+  return true;
+}
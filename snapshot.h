@@ -0,0 +1,61 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// --- Snapshot Constants ---
+#define SNAPSHOT_MAX_REGIONS 32
+#define SNAPSHOT_MAX_ENTRIES 1024 // frames the history can index at once
+
+// The pieces of memory that make up one world state. Regions are copied
+// back to back, so a frame is just their concatenation.
+typedef struct {
+  void *ptr[SNAPSHOT_MAX_REGIONS];
+  size_t size[SNAPSHOT_MAX_REGIONS];
+  int count;
+  size_t frame_size;
+} SnapshotLayout;
+
+typedef struct {
+  uint32_t offset; // into the arena
+  uint32_t size;   // encoded bytes
+  uint32_t key;    // sequence number of the keyframe this delta is against
+  bool keyframe;
+} SnapshotEntry;
+
+// Per-tick history in a fixed arena. Every `keyframe_interval` frames a raw
+// keyframe is stored; the frames in between are XORed against it and only
+// the non-zero runs are kept. Restoring any frame therefore costs one copy
+// and one delta, however long the history is.
+typedef struct {
+  const SnapshotLayout *layout;
+  uint8_t *arena;
+  size_t arena_size;
+  size_t head; // next write offset
+  SnapshotEntry entries[SNAPSHOT_MAX_ENTRIES];
+  uint32_t first; // sequence number of the oldest frame
+  uint32_t count;
+  uint32_t key; // sequence number of the keyframe new deltas use
+  int keyframe_interval;
+  uint8_t *frame;   // capture/restore scratch, frame_size bytes
+  uint8_t *encoded; // delta scratch, frame_size bytes
+  uint64_t bytes_pushed, frames_pushed;
+} SnapshotRing;
+
+void snapshot_track(SnapshotLayout *layout, void *ptr, size_t size);
+void snapshot_capture(const SnapshotLayout *layout, uint8_t *frame);
+void snapshot_restore(const SnapshotLayout *layout, const uint8_t *frame);
+
+bool snapshot_ring_init(SnapshotRing *ring, const SnapshotLayout *layout,
+                        size_t arena_size, int keyframe_interval);
+void snapshot_ring_free(SnapshotRing *ring);
+void snapshot_ring_clear(SnapshotRing *ring);
+// Captures the current state as the newest frame, evicting the oldest ones
+// if the arena is full.
+void snapshot_ring_push(SnapshotRing *ring);
+// Restores the newest frame and drops it. Returns false if history is empty.
+bool snapshot_ring_pop(SnapshotRing *ring);
+
+#endif
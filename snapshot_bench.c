@@ -0,0 +1,155 @@
+#include "snapshot.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Records a synthetic world shaped like main.c's (same arrays and sizes,
+// similar motion per tick) and reports the history cost per second of play
+// plus the time to snapshot and restore. Every restored frame is checked
+// against a plain copy of the world taken on the same tick.
+#define FPS 120
+#define MAX_PLATFORMS 50
+#define MAX_PROJECTILES 30
+#define MAX_MONSTER_PROJECTILES 20
+#define MAX_MONSTERS 10
+
+typedef struct {
+    float x, y, vx, vy;
+    bool on_ground;
+} Player;
+typedef struct {
+    float x, y, width, height;
+} Platform;
+typedef struct {
+    float x, y, vx, vy;
+    bool active;
+} Projectile;
+typedef struct {
+    float x, y;
+    int health;
+    bool active;
+    float shoot_cooldown;
+    float vx, vy;
+    bool on_ground;
+    float drop_from;
+} Monster;
+typedef struct {
+    Player player;
+    Platform ground_segments[3];
+    Platform platforms[MAX_PLATFORMS];
+    int num_platforms;
+    Projectile projectiles[MAX_PROJECTILES];
+    Projectile monster_projectiles[MAX_MONSTER_PROJECTILES];
+    Monster monsters[MAX_MONSTERS];
+    float camera_x;
+    int scalars[16];
+} World;
+
+static double now_ns(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void step(World *w, int tick) {
+    w->player.x += 8;
+    w->camera_x = w->player.x - 400;
+    w->scalars[0] = tick;
+    for (int i = 0; i < MAX_MONSTERS; i++) {
+        w->monsters[i].x += (i % 2) ? 3 : -3;
+        w->monsters[i].shoot_cooldown -= 1.0f / FPS;
+    }
+    for (int i = 0; i < MAX_PROJECTILES; i++) {
+        if (tick % 15 == 0 && !w->projectiles[i].active) {
+            w->projectiles[i] = (Projectile){w->player.x, 500, 20, -3, true};
+            break;
+        }
+    }
+    for (int i = 0; i < MAX_PROJECTILES; i++) {
+        if (w->projectiles[i].active) {
+            w->projectiles[i].x += w->projectiles[i].vx;
+            w->projectiles[i].y += w->projectiles[i].vy;
+            w->projectiles[i].active = w->projectiles[i].y > 0;
+        }
+    }
+    for (int i = 0; i < MAX_MONSTER_PROJECTILES; i++) {
+        w->monster_projectiles[i].x -= 10;
+    }
+    // A platform is generated every few ticks and the oldest culled.
+    if (tick % 24 == 0) {
+        for (int i = 0; i < MAX_PLATFORMS - 1; i++) {
+            w->platforms[i] = w->platforms[i + 1];
+        }
+        w->platforms[MAX_PLATFORMS - 1].x += 190;
+    }
+}
+
+int main(int argc, char **argv) {
+    int seconds = argc > 1 ? atoi(argv[1]) : 60;
+    int interval = argc > 2 ? atoi(argv[2]) : 30;
+    size_t arena = argc > 3 ? (size_t)atol(argv[3]) : 1024 * 1024;
+
+    static World world;
+    for (int i = 0; i < MAX_PLATFORMS; i++) {
+        world.platforms[i] = (Platform){400 + i * 190.0f, 500, 190, 50};
+    }
+    world.num_platforms = MAX_PLATFORMS;
+    for (int i = 0; i < MAX_MONSTERS; i++) {
+        world.monsters[i] = (Monster){i * 300.0f, 468, 3, true, 1, 0, 0,
+                                      true, 0};
+    }
+
+    SnapshotLayout layout = {0};
+    snapshot_track(&layout, &world, sizeof(world));
+    SnapshotRing ring;
+    if (!snapshot_ring_init(&ring, &layout, arena, interval)) {
+        return 1;
+    }
+
+    World *trail = malloc(SNAPSHOT_MAX_ENTRIES * sizeof(World));
+    if (!trail) {
+        return 1;
+    }
+    int ticks = seconds * FPS;
+    double push_ns = 0;
+    for (int t = 0; t < ticks; t++) {
+        step(&world, t);
+        trail[t % SNAPSHOT_MAX_ENTRIES] = world;
+        double start = now_ns();
+        snapshot_ring_push(&ring);
+        push_ns += now_ns() - start;
+    }
+
+    uint32_t held = ring.count;
+    double pop_ns = 0;
+    int mismatches = 0;
+    for (int t = ticks - 1; ring.count > 0; t--) {
+        double start = now_ns();
+        snapshot_ring_pop(&ring);
+        pop_ns += now_ns() - start;
+        if (memcmp(&world, &trail[t % SNAPSHOT_MAX_ENTRIES], sizeof(world))) {
+            mismatches++;
+        }
+    }
+    pop_ns /= held ? held : 1;
+
+    double per_second = (double)ring.bytes_pushed / ring.frames_pushed * FPS;
+    printf("frame: %zu bytes raw, keyframe every %d ticks\n",
+           layout.frame_size, interval);
+    printf("history: %.1f KiB per second (raw would be %.1f KiB)\n",
+           per_second / 1024, (double)layout.frame_size * FPS / 1024);
+    printf("ring: %zu KiB holds %u frames (%.1f s)\n", arena / 1024, held,
+           (double)held / FPS);
+    printf("snapshot: %.0f ns/tick, restore: %.0f ns\n", push_ns / ticks,
+           pop_ns);
+    printf("%d/%u restored frames differ from the recorded world\n",
+           mismatches, held);
+
+    snapshot_ring_free(&ring);
+    free(trail);
+
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,265 @@
+#define _GNU_SOURCE
+#include "telemetry.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+static const char *event_names[TELEMETRY_EVENT_COUNT] = {
+    "none",         "damage",         "death",
+    "wave_start",   "wave_cleared",   "door_spawned",
+    "question_shown", "answer",       "stage_clear",
+    "rewind",       "retry",
+};
+
+const char *telemetry_event_name(uint16_t type) {
+  return type < TELEMETRY_EVENT_COUNT ? event_names[type] : "unknown";
+}
+
+static void segment_path(const Telemetry *t, uint32_t segment, char *buf,
+                         size_t size) {
+  snprintf(buf, size, "%s/session_%llu_%04u.tlm", t->dir,
+           (unsigned long long)t->session, segment);
+}
+
+// Records the final count so the decoder does not have to scan, then unmaps.
+// The page cache writes the segment back on its own time.
+static void seal_segment(const Telemetry *t, TelemetryHeader *h,
+                         uint32_t count) {
+  h->count = count;
+  munmap(h, t->map_size);
+}
+
+static uint32_t records_written(const Telemetry *t) {
+  return (uint32_t)(t->cursor - (TelemetryRecord *)(t->header + 1));
+}
+
+// The file is sparse after ftruncate, so the first store to each page would
+// take a write fault and a block allocation inside telemetry_emit(). Take
+// them all here instead. MAP_POPULATE is no help: it only read-faults shared
+// mappings.
+static void prefault_for_write(void *map, size_t size) {
+#ifdef MADV_POPULATE_WRITE
+  if (madvise(map, size, MADV_POPULATE_WRITE) == 0)
+    return;
+#endif
+  long page = sysconf(_SC_PAGESIZE);
+  for (size_t off = 0; off < size; off += (size_t)page) {
+    ((volatile uint8_t *)map)[off] = 0;
+  }
+}
+
+static TelemetryHeader *map_segment(const Telemetry *t, uint32_t segment) {
+  char path[256];
+  segment_path(t, segment, path, sizeof(path));
+  int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    fprintf(stderr, "Telemetry: can't open '%s': %s\n", path, strerror(errno));
+    return NULL;
+  }
+  if (ftruncate(fd, (off_t)t->map_size) != 0) {
+    fprintf(stderr, "Telemetry: can't size '%s': %s\n", path, strerror(errno));
+    close(fd);
+    return NULL;
+  }
+  void *map =
+      mmap(NULL, t->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    fprintf(stderr, "Telemetry: can't map '%s': %s\n", path, strerror(errno));
+    return NULL;
+  }
+  prefault_for_write(map, t->map_size);
+  TelemetryHeader *h = map;
+  memcpy(h->magic, TELEMETRY_MAGIC, sizeof(h->magic));
+  h->version = TELEMETRY_VERSION;
+  h->record_size = sizeof(TelemetryRecord);
+  h->capacity = t->capacity;
+  h->count = 0;
+  h->segment = segment;
+  h->ticks_per_second = t->ticks_per_second;
+  h->session = t->session;
+  return h;
+}
+
+static void activate(Telemetry *t, TelemetryHeader *h) {
+  t->header = h;
+  t->segment = h->segment;
+  t->cursor = (TelemetryRecord *)(h + 1);
+  t->end = t->cursor + t->capacity;
+}
+
+// Worker: seal whatever was retired, then keep one spare segment ready.
+// It runs at idle priority: when it shares a core with the game thread, the
+// wakeup from telemetry_rotate() must not preempt the tick that sent it. The
+// work then happens while the game waits for its next timer event.
+static void *telemetry_worker(void *arg) {
+  Telemetry *t = arg;
+#ifdef SCHED_IDLE
+  pthread_setschedparam(pthread_self(), SCHED_IDLE,
+                        &(struct sched_param){.sched_priority = 0});
+#endif
+  pthread_mutex_lock(&t->lock);
+  while (!t->stopping) {
+    if (t->retired) {
+      TelemetryHeader *h = t->retired;
+      t->retired = NULL;
+      pthread_mutex_unlock(&t->lock);
+      seal_segment(t, h, h->count);
+      pthread_mutex_lock(&t->lock);
+    } else if (!t->spare) {
+      uint32_t segment = t->next_segment++;
+      pthread_mutex_unlock(&t->lock);
+      TelemetryHeader *h = map_segment(t, segment);
+      pthread_mutex_lock(&t->lock);
+      if (!h)
+        break; // rotate falls back to mapping on the game thread
+      t->spare = h;
+    } else {
+      pthread_cond_wait(&t->wake, &t->lock);
+    }
+  }
+  pthread_mutex_unlock(&t->lock);
+  return NULL;
+}
+
+bool telemetry_open(Telemetry *t, const char *dir, uint32_t segment_records,
+                    uint32_t ticks_per_second) {
+  memset(t, 0, sizeof(*t));
+  pthread_mutex_init(&t->lock, NULL);
+  pthread_cond_init(&t->wake, NULL);
+  snprintf(t->dir, sizeof(t->dir), "%s", dir);
+  t->capacity =
+      segment_records ? segment_records : TELEMETRY_DEFAULT_SEGMENT_RECORDS;
+  t->map_size =
+      sizeof(TelemetryHeader) + (size_t)t->capacity * sizeof(TelemetryRecord);
+  t->ticks_per_second = ticks_per_second;
+  struct timespec now;
+  timespec_get(&now, TIME_UTC);
+  t->session = (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+  if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+    fprintf(stderr, "Telemetry: can't create '%s': %s\n", dir,
+            strerror(errno));
+    t->dir[0] = '\0';
+    return false;
+  }
+  TelemetryHeader *h = map_segment(t, 0);
+  if (!h) {
+    t->dir[0] = '\0';
+    return false;
+  }
+  activate(t, h);
+  t->next_segment = 1;
+  // Without the worker every rotation simply maps on the game thread.
+  t->worker_running =
+      pthread_create(&t->worker, NULL, telemetry_worker, t) == 0;
+  return true;
+}
+
+void telemetry_close(Telemetry *t) {
+  if (t->capacity == 0)
+    return;
+  if (t->worker_running) {
+    pthread_mutex_lock(&t->lock);
+    t->stopping = true;
+    pthread_cond_signal(&t->wake);
+    pthread_mutex_unlock(&t->lock);
+    pthread_join(t->worker, NULL);
+    t->worker_running = false;
+  }
+  if (t->retired) {
+    seal_segment(t, t->retired, t->retired->count);
+    t->retired = NULL;
+  }
+  if (t->spare) {
+    // Never written to: drop the file rather than leave an empty segment.
+    char path[256];
+    segment_path(t, t->spare->segment, path, sizeof(path));
+    munmap(t->spare, t->map_size);
+    unlink(path);
+    t->spare = NULL;
+  }
+  if (t->header) {
+    seal_segment(t, t->header, records_written(t));
+    t->header = NULL;
+    t->cursor = t->end = NULL;
+  }
+  pthread_mutex_destroy(&t->lock);
+  pthread_cond_destroy(&t->wake);
+  t->dir[0] = '\0';
+  t->capacity = 0;
+}
+
+bool telemetry_rotate(Telemetry *t) {
+  if (t->dir[0] == '\0')
+    return false;
+  TelemetryHeader *full = t->header;
+  uint32_t count = records_written(t);
+  TelemetryHeader *next = NULL;
+  bool handed_off = false;
+  if (t->worker_running) {
+    pthread_mutex_lock(&t->lock);
+    next = t->spare;
+    t->spare = NULL;
+    if (!t->retired) {
+      full->count = count;
+      t->retired = full;
+      handed_off = true;
+    }
+    if (!next) {
+      t->stalls++;
+      next = map_segment(t, t->next_segment++);
+    }
+    pthread_mutex_unlock(&t->lock);
+    pthread_cond_signal(&t->wake);
+  } else {
+    next = map_segment(t, t->next_segment++);
+  }
+  if (!handed_off) {
+    t->stalls++;
+    seal_segment(t, full, count);
+  }
+  t->header = NULL;
+  t->cursor = t->end = NULL;
+  if (!next) {
+    t->dir[0] = '\0'; // stop retrying on every event
+    return false;
+  }
+  activate(t, next);
+  return true;
+}
+
+long telemetry_decode_segment(const char *path, FILE *out) {
+  FILE *in = fopen(path, "rb");
+  if (!in) {
+    fprintf(stderr, "Can't open '%s'\n", path);
+    return -1;
+  }
+  TelemetryHeader h;
+  if (fread(&h, sizeof(h), 1, in) != 1 ||
+      memcmp(h.magic, TELEMETRY_MAGIC, sizeof(h.magic)) != 0 ||
+      h.record_size != sizeof(TelemetryRecord)) {
+    fprintf(stderr, "'%s' is not a telemetry segment\n", path);
+    fclose(in);
+    return -1;
+  }
+  double tick_seconds = h.ticks_per_second ? 1.0 / h.ticks_per_second : 0;
+  uint32_t limit = h.count ? h.count : h.capacity;
+  long rows = 0;
+  TelemetryRecord r;
+  for (uint32_t i = 0; i < limit && fread(&r, sizeof(r), 1, in) == 1; i++) {
+    if (r.type == TELEMETRY_NONE)
+      break;
+    fprintf(out, "%llu,%u,%u,%.4f,%s,%u,%d,%d,%d,%.1f,%.1f\n",
+            (unsigned long long)h.session, h.segment, r.tick,
+            r.tick * tick_seconds, telemetry_event_name(r.type), r.stage, r.a,
+            r.b, r.c, r.x, r.y);
+    rows++;
+  }
+  fclose(in);
+  return rows;
+}
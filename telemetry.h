@@ -0,0 +1,106 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// --- Telemetry Constants ---
+#define TELEMETRY_MAGIC "MRPGTLM1"
+#define TELEMETRY_VERSION 1
+#define TELEMETRY_DEFAULT_SEGMENT_RECORDS 65536 // 2 MiB per segment file
+
+// Event types. TELEMETRY_NONE must stay 0: segments are pre-sized with zeros,
+// so the first zero record marks the end of a segment that was not closed.
+typedef enum {
+  TELEMETRY_NONE = 0,
+  TELEMETRY_DAMAGE,         // a = lives left
+  TELEMETRY_DEATH,          // a = stage ticks survived
+  TELEMETRY_WAVE_START,     // a = monsters to spawn
+  TELEMETRY_WAVE_CLEARED,   // a = wave ticks
+  TELEMETRY_DOOR_SPAWNED,   // x, y = door position
+  TELEMETRY_QUESTION_SHOWN, // a = question id
+  TELEMETRY_ANSWER,         // a = question id, b = selected, c = correct (0/1)
+  TELEMETRY_STAGE_CLEAR,    // a = stage ticks
+  TELEMETRY_REWIND,         // a = ticks rewound, b = game tick resumed at
+  TELEMETRY_RETRY,          // a = ticks lost going back to the checkpoint
+  TELEMETRY_EVENT_COUNT
+} TelemetryEvent;
+
+// One fixed-size record. Keep it at 32 bytes so records never straddle a
+// cache line and the decoder can index a segment directly.
+typedef struct {
+  uint32_t tick; // session tick, never goes back on rewind or retry
+  uint16_t type;
+  uint16_t stage;
+  int32_t a, b, c;
+  float x, y;
+  uint32_t reserved;
+} TelemetryRecord;
+_Static_assert(sizeof(TelemetryRecord) == 32, "TelemetryRecord must be 32B");
+
+// Segment file header, followed by `capacity` records.
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t record_size;
+  uint32_t capacity;
+  uint32_t count; // written on rotate/close; 0 means scan for TELEMETRY_NONE
+  uint32_t segment;
+  uint32_t ticks_per_second;
+  uint64_t session;
+  uint8_t reserved[24];
+} TelemetryHeader;
+_Static_assert(sizeof(TelemetryHeader) == 64, "TelemetryHeader must be 64B");
+
+// A worker thread keeps the next segment mapped and pre-faulted, and seals
+// full ones, so rotating inside the tick is only a pointer swap. Everything
+// below `lock` is shared with the worker.
+typedef struct {
+  TelemetryRecord *cursor; // next free record, NULL when disabled
+  TelemetryRecord *end;
+  TelemetryHeader *header; // start of the current mapping
+  size_t map_size;
+  uint32_t capacity;
+  uint32_t segment;
+  uint32_t ticks_per_second;
+  uint64_t session;
+  char dir[192];
+  uint32_t stalls; // map or seal calls the game thread had to make itself
+  bool worker_running;
+  pthread_t worker;
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  bool stopping;
+  uint32_t next_segment;    // number the next mapped segment gets
+  TelemetryHeader *spare;   // mapped and ready, NULL while being prepared
+  TelemetryHeader *retired; // full segment waiting to be sealed
+} Telemetry;
+
+// Opens the first segment in `dir` (created if missing). On failure the log
+// stays disabled and telemetry_emit() becomes a no-op.
+bool telemetry_open(Telemetry *t, const char *dir, uint32_t segment_records,
+                    uint32_t ticks_per_second);
+void telemetry_close(Telemetry *t);
+// Slow path: swaps in the spare segment and hands the full one to the worker.
+// Maps synchronously only if the worker has not caught up.
+bool telemetry_rotate(Telemetry *t);
+const char *telemetry_event_name(uint16_t type);
+// Writes every record of one segment file as CSV rows; returns rows written
+// or -1 if the file is not a telemetry segment.
+long telemetry_decode_segment(const char *path, FILE *out);
+
+// Hot path: a bounds check and a 32-byte store into the mapped segment.
+static inline void telemetry_emit(Telemetry *t, uint32_t tick,
+                                  TelemetryEvent type, int stage, int32_t a,
+                                  int32_t b, int32_t c, float x, float y) {
+  if (__builtin_expect(t->cursor == t->end, 0)) {
+    if (!telemetry_rotate(t))
+      return;
+  }
+  *t->cursor++ = (TelemetryRecord){
+      tick, (uint16_t)type, (uint16_t)stage, a, b, c, x, y, 0};
+}
+
+#endif
@@ -0,0 +1,102 @@
+#include "telemetry.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <threads.h>
+#include <time.h>
+
+// Measures telemetry_emit() on fresh segment files, reporting separately:
+// - the steady-state emit, with no rotation inside the timed region,
+// - a rotation when the worker already has the next segment ready,
+// - a rotation that stalls because it has not.
+static double now_ns(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void emit(Telemetry *tlm, long i) {
+    telemetry_emit(tlm, (uint32_t)i, TELEMETRY_DAMAGE, 1, (int32_t)i, 0, 0,
+                   (float)i, 0);
+}
+
+// Sleeps until the worker has sealed the last segment and mapped a spare,
+// the way the game idles between ticks, so the next rotation is the pointer
+// swap the game normally gets. Spinning would starve the idle-priority
+// worker on a single core.
+static void wait_for_spare(Telemetry *tlm) {
+    for (bool ready = false; !ready;) {
+        pthread_mutex_lock(&tlm->lock);
+        ready = tlm->spare && !tlm->retired;
+        pthread_mutex_unlock(&tlm->lock);
+        if (!ready) {
+            thrd_sleep(&(struct timespec){.tv_nsec = 100000}, NULL);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    int segments = argc > 1 ? atoi(argv[1]) : 16;
+    const char *dir = argc > 2 ? argv[2] : "telemetry_bench";
+
+    Telemetry tlm;
+    if (!telemetry_open(&tlm, dir, TELEMETRY_DEFAULT_SEGMENT_RECORDS, 120)) {
+        return 1;
+    }
+    if (!tlm.worker_running) {
+        fprintf(stderr, "Telemetry worker did not start.\n");
+        telemetry_close(&tlm);
+        return 1;
+    }
+
+    long i = 0, emits = 0;
+    double emit_ns = 0, ready_ns = 0, ready_max_ns = 0;
+    double stall_ns = 0, stall_max_ns = 0;
+    int ready_rotations = 0, stall_rotations = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        for (int s = 0; s < segments; s++) {
+            // The first pass waits for the worker between segments; the
+            // second rotates as soon as a segment is full, which outruns it
+            // and takes the stall path.
+            if (pass == 0) {
+                wait_for_spare(&tlm);
+            }
+            long n = tlm.end - tlm.cursor;
+            double start = now_ns();
+            for (long k = 0; k < n; k++) {
+                emit(&tlm, i++);
+            }
+            emit_ns += now_ns() - start;
+            emits += n;
+
+            uint32_t stalls = tlm.stalls;
+            start = now_ns();
+            emit(&tlm, i++);
+            double took = now_ns() - start;
+            if (tlm.stalls == stalls) {
+                ready_ns += took;
+                ready_max_ns = took > ready_max_ns ? took : ready_max_ns;
+                ready_rotations++;
+            } else {
+                stall_ns += took;
+                stall_max_ns = took > stall_max_ns ? took : stall_max_ns;
+                stall_rotations++;
+            }
+        }
+    }
+    telemetry_close(&tlm);
+
+    printf("emit:   %ld events, %.2f ns/event with no rotation\n", emits,
+           emit_ns / emits);
+    printf("rotate: %d with the spare ready, %.2f us mean, %.2f us max\n",
+           ready_rotations,
+           ready_rotations ? ready_ns / ready_rotations / 1000 : 0,
+           ready_max_ns / 1000);
+    printf("stall:  %d mapped on the emitting thread, %.1f us mean, "
+           "%.1f us max\n",
+           stall_rotations,
+           stall_rotations ? stall_ns / stall_rotations / 1000 : 0,
+           stall_max_ns / 1000);
+
+    return 0;
+}
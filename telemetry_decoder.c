@@ -0,0 +1,30 @@
+#include "telemetry.h"
+
+#include <stdio.h>
+
+// Converts telemetry segments written by magicrpg into CSV on stdout.
+// Usage: telemetry_decoder telemetry/*.tlm > events.csv
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <segment.tlm>...\n", argv[0]);
+        return 1;
+    }
+
+    printf("session,segment,tick,seconds,event,stage,a,b,c,x,y\n");
+
+    int failed = 0;
+    long total = 0;
+    for (int i = 1; i < argc; i++) {
+        long rows = telemetry_decode_segment(argv[i], stdout);
+        if (rows < 0) {
+            failed++;
+            continue;
+        }
+        total += rows;
+    }
+
+    fprintf(stderr, "Decoded %ld events from %d segment(s).\n", total,
+            argc - 1 - failed);
+
+    return failed ? 1 : 0;
+}
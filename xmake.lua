@@ -2,7 +2,7 @@ add_rules("mode.debug", "mode.release")
 
 target("magicrpg")
     set_kind("binary")
-    add_files("main.c")
+    add_files("main.c", "nav.c", "snapshot.c", "telemetry.c")
     set_languages("c23")
     add_links("allegro_primitives", "allegro_font", "allegro_ttf", "allegro_image", "allegro", "sqlite3")
     add_syslinks("m", "pthread", "dl")
@@ -38,3 +38,49 @@ target("db_creator")
         set_targetdir("build/release")
     end
 
+
+target("telemetry_decoder")
+    set_kind("binary")
+    add_files("telemetry_decoder.c", "telemetry.c")
+    set_languages("c23")
+    add_syslinks("pthread")
+    if is_mode("debug") then
+        set_targetdir("build/debug")
+    else
+        set_targetdir("build/release")
+    end
+
+
+target("telemetry_bench")
+    set_kind("binary")
+    add_files("telemetry_bench.c", "telemetry.c")
+    set_languages("c23")
+    add_syslinks("pthread")
+    if is_mode("debug") then
+        set_targetdir("build/debug")
+    else
+        set_targetdir("build/release")
+    end
+
+
+target("nav_bench")
+    set_kind("binary")
+    add_files("nav_bench.c", "nav.c")
+    set_languages("c23")
+    add_syslinks("m")
+    if is_mode("debug") then
+        set_targetdir("build/debug")
+    else
+        set_targetdir("build/release")
+    end
+
+
+target("snapshot_bench")
+    set_kind("binary")
+    add_files("snapshot_bench.c", "snapshot.c")
+    set_languages("c23")
+    if is_mode("debug") then
+        set_targetdir("build/debug")
+    else
+        set_targetdir("build/release")
+    end